@@ -5,6 +5,16 @@
 #include <map>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -48,7 +58,7 @@ public:
         }
     }
 
-    void writeTreeToFile(ofstream& outfile, int depth = 0) const {
+    void writeTreeToFile(ostream& outfile, int depth = 0) const {
         for (int i = 0; i < depth; ++i) {
             outfile << "  ";
         }
@@ -59,12 +69,103 @@ public:
     }
 };
 
+// binary table file layout (native byte order, every section 4-byte aligned)
+//   TableHeader
+//   uint32_t        nameOffsets[symbolCount]   offset of each symbol name in the name blob
+//   char            names[nameBytes]           NUL-terminated names, padded to 4 bytes
+//   ProductionEntry productions[productionCount]
+//   uint32_t        rhs[rhsCount]              symbol ids of all right-hand sides
+//   int32_t         action[stateCount * terminalCount]
+//   int32_t         goto[stateCount * (symbolCount - terminalCount)]
+// symbol ids [0, terminalCount) are terminals, the rest are non-terminals.
+// ACTION cells are packed as (argument << 2) | kind, 0 meaning "no entry".
+// GOTO cells hold the next state, or -1 if there is no entry.
+const char TABLE_MAGIC[4] = { 'S', 'L', 'R', 'T' };
+const uint32_t TABLE_VERSION = 2;
+const uint32_t TABLE_BYTE_ORDER = 0x01020304;
+
+enum PackedKind { PACKED_NONE = 0, PACKED_SHIFT = 1, PACKED_REDUCE = 2, PACKED_ACCEPT = 3 };
+
+struct TableHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t symbolCount;
+    uint64_t fingerprint; // FNV-1a over symbol names and productions
+    uint32_t terminalCount;
+    uint32_t productionCount;
+    uint32_t stateCount;
+    uint32_t rhsCount;
+    uint32_t nameBytes;
+    uint32_t reserved;
+    uint64_t tableChecksum; // FNV-1a over the ACTION and GOTO sections
+};
+
+struct ProductionEntry {
+    uint32_t lhs;
+    uint32_t rhsBegin;
+    uint32_t rhsLength;
+};
+
+const uint64_t FNV_OFFSET_BASIS = 1469598103934665603ULL;
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// grammar fingerprint : changes whenever a symbol name, the terminal split, or a production changes
+uint64_t grammarFingerprint(uint32_t terminalCount, const vector<const char*>& symbolNames,
+                            const ProductionEntry* prods, uint32_t productionCount, const uint32_t* rhs) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    auto mix = [&hash](const void* data, size_t size) {
+        hash = fnv1a(hash, data, size);
+    };
+    mix(&terminalCount, sizeof(terminalCount));
+    for (const char* name : symbolNames) {
+        mix(name, strlen(name) + 1);
+    }
+    for (uint32_t p = 0; p < productionCount; ++p) {
+        mix(&prods[p].lhs, sizeof(uint32_t));
+        mix(&prods[p].rhsLength, sizeof(uint32_t));
+        mix(rhs + prods[p].rhsBegin, prods[p].rhsLength * sizeof(uint32_t));
+    }
+    return hash;
+}
+
+string fingerprintToString(uint64_t fingerprint) {
+    ostringstream out;
+    out << "0x" << hex;
+    out.width(16);
+    out.fill('0');
+    out << fingerprint;
+    return out.str();
+}
+
 class Parser {
 private:
     vector<pair<string, vector<string>>> productions; //storing CFG
     map<int, map<string, Action>> ACTION; // storing ACTION table
     map<int, map<string, int>> GOTO; // storing GOTO table
 
+    // table image used by parse(), either built in memory from the tables above or mmap'd from a file
+    vector<char> ownedImage;
+    void* mappedImage = nullptr;
+    size_t mappedSize = 0;
+
+    // views into the current image, set by attachImage() once the image is validated
+    const TableHeader* header = nullptr;
+    const ProductionEntry* prodTable = nullptr;
+    const uint32_t* rhsTable = nullptr;
+    const int32_t* actionTable = nullptr;
+    const int32_t* gotoTable = nullptr;
+    vector<const char*> symbolNames;
+    map<string, int> terminalIds;
+
     void initializeProductions() {
         productions = {
             //CFG
@@ -521,12 +622,362 @@ private:
         GOTO[83]["IFELSE"] = 43;
     }
 
+    static void appendBytes(vector<char>& image, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        image.insert(image.end(), bytes, bytes + size);
+    }
+
+    // compile productions, ACTION and GOTO into the binary table layout
+    vector<char> buildImage() const {
+        // non-terminals are the left-hand sides, terminals are everything else used by the grammar or ACTION
+        vector<string> nonterminals;
+        map<string, int> isNonterminal;
+        for (const auto& production : productions) {
+            if (isNonterminal.insert({ production.first, 1 }).second) {
+                nonterminals.push_back(production.first);
+            }
+        }
+        vector<string> terminals;
+        map<string, int> seen;
+        auto addTerminal = [&](const string& sym) {
+            if (sym.empty() || isNonterminal.count(sym) || !seen.insert({ sym, 1 }).second) {
+                return;
+            }
+            terminals.push_back(sym);
+        };
+        for (const auto& production : productions) {
+            for (const auto& sym : production.second) {
+                addTerminal(sym);
+            }
+        }
+        for (const auto& row : ACTION) {
+            for (const auto& entry : row.second) {
+                addTerminal(entry.first);
+            }
+        }
+        addTerminal("$");
+
+        map<string, uint32_t> symbolIds;
+        vector<string> symbols = terminals;
+        symbols.insert(symbols.end(), nonterminals.begin(), nonterminals.end());
+        for (uint32_t i = 0; i < symbols.size(); ++i) {
+            symbolIds[symbols[i]] = i;
+        }
+
+        vector<uint32_t> nameOffsets;
+        string names;
+        for (const auto& sym : symbols) {
+            nameOffsets.push_back(names.size());
+            names += sym;
+            names += '\0';
+        }
+        while (names.size() % 4 != 0) {
+            names += '\0';
+        }
+
+        vector<ProductionEntry> prods;
+        vector<uint32_t> rhs;
+        for (const auto& production : productions) {
+            ProductionEntry entry = { symbolIds[production.first], (uint32_t)rhs.size(), 0 };
+            for (const auto& sym : production.second) {
+                if (!sym.empty()) {
+                    rhs.push_back(symbolIds[sym]);
+                    entry.rhsLength++;
+                }
+            }
+            prods.push_back(entry);
+        }
+
+        int stateCount = 0;
+        for (const auto& row : ACTION) {
+            stateCount = max(stateCount, row.first + 1);
+        }
+        for (const auto& row : GOTO) {
+            stateCount = max(stateCount, row.first + 1);
+        }
+
+        uint32_t terminalCount = terminals.size();
+        uint32_t nonterminalCount = nonterminals.size();
+        vector<int32_t> action(stateCount * terminalCount, 0);
+        for (const auto& row : ACTION) {
+            for (const auto& entry : row.second) {
+                int32_t& cell = action[row.first * terminalCount + symbolIds[entry.first]];
+                const Action& act = entry.second;
+                if (act.type == ActionType::SHIFT) {
+                    cell = (act.state << 2) | PACKED_SHIFT;
+                }
+                else if (act.type == ActionType::REDUCE) {
+                    cell = (act.production << 2) | PACKED_REDUCE;
+                }
+                else if (act.type == ActionType::ACCEPT) {
+                    cell = PACKED_ACCEPT;
+                }
+            }
+        }
+        vector<int32_t> gotoCells(stateCount * nonterminalCount, -1);
+        for (const auto& row : GOTO) {
+            for (const auto& entry : row.second) {
+                gotoCells[row.first * nonterminalCount + symbolIds[entry.first] - terminalCount] = entry.second;
+            }
+        }
+
+        TableHeader head = {};
+        memcpy(head.magic, TABLE_MAGIC, sizeof(head.magic));
+        head.version = TABLE_VERSION;
+        head.byteOrder = TABLE_BYTE_ORDER;
+        head.symbolCount = symbols.size();
+        head.terminalCount = terminalCount;
+        head.productionCount = prods.size();
+        head.stateCount = stateCount;
+        head.rhsCount = rhs.size();
+        head.nameBytes = names.size();
+        vector<const char*> namePointers;
+        for (uint32_t offset : nameOffsets) {
+            namePointers.push_back(names.data() + offset);
+        }
+        head.fingerprint = grammarFingerprint(terminalCount, namePointers, prods.data(), prods.size(), rhs.data());
+        head.tableChecksum = fnv1a(FNV_OFFSET_BASIS, action.data(), action.size() * sizeof(int32_t));
+        head.tableChecksum = fnv1a(head.tableChecksum, gotoCells.data(), gotoCells.size() * sizeof(int32_t));
+
+        vector<char> image;
+        appendBytes(image, &head, sizeof(head));
+        appendBytes(image, nameOffsets.data(), nameOffsets.size() * sizeof(uint32_t));
+        appendBytes(image, names.data(), names.size());
+        appendBytes(image, prods.data(), prods.size() * sizeof(ProductionEntry));
+        appendBytes(image, rhs.data(), rhs.size() * sizeof(uint32_t));
+        appendBytes(image, action.data(), action.size() * sizeof(int32_t));
+        appendBytes(image, gotoCells.data(), gotoCells.size() * sizeof(int32_t));
+        return image;
+    }
+
+    void releaseImage() {
+        if (mappedImage) {
+            munmap(mappedImage, mappedSize);
+            mappedImage = nullptr;
+            mappedSize = 0;
+        }
+        ownedImage.clear();
+        header = nullptr;
+        symbolNames.clear();
+        terminalIds.clear();
+    }
+
+    // validate a whole table image once, so parse() can index it without further checks
+    bool attachImage(const char* data, size_t size, string& error) {
+        if (size < sizeof(TableHeader)) {
+            error = "Error: table file is too small for a header\n";
+            return false;
+        }
+        const TableHeader* head = reinterpret_cast<const TableHeader*>(data);
+        if (memcmp(head->magic, TABLE_MAGIC, sizeof(head->magic)) != 0) {
+            error = "Error: not a table file (bad magic)\n";
+            return false;
+        }
+        if (head->byteOrder != TABLE_BYTE_ORDER) {
+            error = "Error: table file was written with a different byte order\n";
+            return false;
+        }
+        if (head->version != TABLE_VERSION) {
+            error = "Error: table file version " + to_string(head->version) + " is not supported (expected " + to_string(TABLE_VERSION) + ")\n";
+            return false;
+        }
+        if (head->terminalCount == 0 || head->terminalCount >= head->symbolCount || head->productionCount == 0 || head->stateCount == 0) {
+            error = "Error: table file has empty symbol, production or state tables\n";
+            return false;
+        }
+
+        uint64_t nonterminalCount = head->symbolCount - head->terminalCount;
+        uint64_t offset = sizeof(TableHeader);
+        uint64_t nameOffsetsAt = offset;
+        offset += (uint64_t)head->symbolCount * sizeof(uint32_t);
+        uint64_t namesAt = offset;
+        offset += head->nameBytes;
+        uint64_t prodsAt = offset;
+        offset += (uint64_t)head->productionCount * sizeof(ProductionEntry);
+        uint64_t rhsAt = offset;
+        offset += (uint64_t)head->rhsCount * sizeof(uint32_t);
+        uint64_t actionAt = offset;
+        offset += (uint64_t)head->stateCount * head->terminalCount * sizeof(int32_t);
+        uint64_t gotoAt = offset;
+        offset += (uint64_t)head->stateCount * nonterminalCount * sizeof(int32_t);
+        if (head->nameBytes % 4 != 0 || offset != size) {
+            error = "Error: table file size does not match its header\n";
+            return false;
+        }
+        // ACTION and GOTO are the last two sections, so one pass covers both
+        if (fnv1a(FNV_OFFSET_BASIS, data + actionAt, size - actionAt) != head->tableChecksum) {
+            error = "Error: ACTION/GOTO checksum mismatch, table file is corrupt\n";
+            return false;
+        }
+
+        const uint32_t* nameOffsets = reinterpret_cast<const uint32_t*>(data + nameOffsetsAt);
+        const char* names = data + namesAt;
+        vector<const char*> namePointers;
+        map<string, int> ids;
+        for (uint32_t i = 0; i < head->symbolCount; ++i) {
+            if (nameOffsets[i] >= head->nameBytes || !memchr(names + nameOffsets[i], '\0', head->nameBytes - nameOffsets[i])) {
+                error = "Error: symbol " + to_string(i) + " has a bad name offset\n";
+                return false;
+            }
+            const char* name = names + nameOffsets[i];
+            if (!ids.insert({ name, (int)i }).second) {
+                error = "Error: symbol name '" + string(name) + "' appears twice\n";
+                return false;
+            }
+            namePointers.push_back(name);
+        }
+        if (!ids.count("$") || ids["$"] >= (int)head->terminalCount) {
+            error = "Error: table file has no end-of-input terminal '$'\n";
+            return false;
+        }
+
+        const ProductionEntry* prods = reinterpret_cast<const ProductionEntry*>(data + prodsAt);
+        const uint32_t* rhs = reinterpret_cast<const uint32_t*>(data + rhsAt);
+        for (uint32_t p = 0; p < head->productionCount; ++p) {
+            if (prods[p].lhs < head->terminalCount || prods[p].lhs >= head->symbolCount
+                || (uint64_t)prods[p].rhsBegin + prods[p].rhsLength > head->rhsCount) {
+                error = "Error: production " + to_string(p) + " is out of range\n";
+                return false;
+            }
+            for (uint32_t i = 0; i < prods[p].rhsLength; ++i) {
+                if (rhs[prods[p].rhsBegin + i] >= head->symbolCount) {
+                    error = "Error: production " + to_string(p) + " uses an unknown symbol\n";
+                    return false;
+                }
+            }
+        }
+
+        const int32_t* action = reinterpret_cast<const int32_t*>(data + actionAt);
+        for (uint64_t i = 0; i < (uint64_t)head->stateCount * head->terminalCount; ++i) {
+            int32_t kind = action[i] & 3;
+            int32_t argument = action[i] >> 2;
+            bool valid = (kind == PACKED_NONE && argument == 0)
+                || (kind == PACKED_SHIFT && argument >= 0 && (uint32_t)argument < head->stateCount)
+                || (kind == PACKED_REDUCE && argument >= 0 && (uint32_t)argument < head->productionCount)
+                || (kind == PACKED_ACCEPT && argument == 0);
+            if (!valid) {
+                error = "Error: bad ACTION entry for state " + to_string(i / head->terminalCount) + " and token '" + namePointers[i % head->terminalCount] + "'\n";
+                return false;
+            }
+        }
+        const int32_t* gotoCells = reinterpret_cast<const int32_t*>(data + gotoAt);
+        for (uint64_t i = 0; i < head->stateCount * nonterminalCount; ++i) {
+            if (gotoCells[i] < -1 || gotoCells[i] >= (int32_t)head->stateCount) {
+                error = "Error: bad GOTO entry for state " + to_string(i / nonterminalCount) + "\n";
+                return false;
+            }
+        }
+
+        if (grammarFingerprint(head->terminalCount, namePointers, prods, head->productionCount, rhs) != head->fingerprint) {
+            error = "Error: grammar fingerprint mismatch, table file is corrupt\n";
+            return false;
+        }
+
+        header = head;
+        prodTable = prods;
+        rhsTable = rhs;
+        actionTable = action;
+        gotoTable = gotoCells;
+        symbolNames = namePointers;
+        for (uint32_t i = 0; i < head->terminalCount; ++i) {
+            terminalIds[namePointers[i]] = i;
+        }
+        return true;
+    }
+
+    Action actionAt(int state, int terminal) const {
+        int32_t cell = actionTable[state * header->terminalCount + terminal];
+        switch (cell & 3) {
+        case PACKED_SHIFT: return { ActionType::SHIFT, cell >> 2 };
+        case PACKED_REDUCE: return { ActionType::REDUCE, 0, cell >> 2 };
+        case PACKED_ACCEPT: return { ActionType::ACCEPT };
+        default: return {};
+        }
+    }
+
+    int gotoAt(int state, uint32_t nonterminal) const {
+        return gotoTable[state * (header->symbolCount - header->terminalCount) + nonterminal - header->terminalCount];
+    }
+
 public:
-    Parser() {
+    Parser() {}
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+    ~Parser() {
+        releaseImage();
+    }
+
+    // use the grammar and tables compiled into this program
+    bool useBuiltinTables(string& error) {
+        releaseImage();
         initializeProductions();
         initializeTables();
+        ownedImage = buildImage();
+        return attachImage(ownedImage.data(), ownedImage.size(), error);
+    }
+
+    // map a table file written by writeTables() and validate it once
+    // the mapping is read-only and shared, so concurrent parsers share the pages in the page cache
+    bool loadTables(const string& filename, string& error) {
+        releaseImage();
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "Error: cannot open table file '" + filename + "'\n";
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            error = "Error: cannot read table file '" + filename + "'\n";
+            return false;
+        }
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            error = "Error: cannot map table file '" + filename + "'\n";
+            return false;
+        }
+        mappedImage = data;
+        mappedSize = info.st_size;
+        if (!attachImage(static_cast<const char*>(data), mappedSize, error)) {
+            releaseImage();
+            return false;
+        }
+        return true;
     }
 
+    // write the built-in grammar and tables as a table file
+    // the file is written next to the target and renamed over it, so parsers that still map
+    // the old file keep reading it and never see a truncated or half-written table
+    bool writeTables(const string& filename, string& error) {
+        if (!useBuiltinTables(error)) {
+            return false;
+        }
+        string tempFilename = filename + ".tmp." + to_string(getpid());
+        ofstream outfile(tempFilename, ios::binary | ios::trunc);
+        outfile.write(ownedImage.data(), ownedImage.size());
+        outfile.flush();
+        outfile.close();
+        if (!outfile) {
+            remove(tempFilename.c_str());
+            error = "Error: cannot write table file '" + tempFilename + "'\n";
+            return false;
+        }
+        if (rename(tempFilename.c_str(), filename.c_str()) != 0) {
+            remove(tempFilename.c_str());
+            error = "Error: cannot replace table file '" + filename + "'\n";
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t fingerprint() const {
+        return header ? header->fingerprint : 0;
+    }
+
+    // debug log output in console window, turned off by the check runner
+    bool trace = true;
+
     // function to print the contents of the stack in the form of parse tree
     void printStack(const stack<int>& states, const stack<TreeNode*>& parseStack) {
         stack<int> tempStates = states;
@@ -566,8 +1017,22 @@ public:
     // for each sequence, if there's any input that doesn't have table entries, it's error.
     // in that case, reject the input sequence.
     bool parse(const vector<string>& tokens, string& output, TreeNode*& parseTree) {
-        stack<int> states;
         stack<TreeNode*> parseStack;
+        bool accepted = parseWithStack(tokens, output, parseTree, parseStack);
+
+        // free the subtrees left on the stack by a rejected sequence
+        while (!parseStack.empty()) {
+            if (parseStack.top() != parseTree) {
+                delete parseStack.top();
+            }
+            parseStack.pop();
+        }
+        return accepted;
+    }
+
+private:
+    bool parseWithStack(const vector<string>& tokens, string& output, TreeNode*& parseTree, stack<TreeNode*>& parseStack) {
+        stack<int> states;
         states.push(0);
 
         int pos = 0;
@@ -576,30 +1041,33 @@ public:
             string token = (pos < tokens.size()) ? tokens[pos] : "$";
 
             // debug log output in console window
-            cout << "State: " << state << ", Token: " << token << endl;
-            printStack(states, parseStack);
+            if (trace) {
+                cout << "State: " << state << ", Token: " << token << endl;
+                printStack(states, parseStack);
+            }
 
-            if (ACTION[state].find(token) == ACTION[state].end()) {
+            auto terminal = terminalIds.find(token);
+            Action action = (terminal != terminalIds.end()) ? actionAt(state, terminal->second) : Action();
+            if (action.type == ActionType::ERROR) {
                 output = "Error: Unexpected token '" + token + "' at position " + to_string(pos) + "\n";
                 output += "Error: No ACTION entry for state " + to_string(state) + " and token '" + token + "'\n";
                 return false;
             }
 
-            Action action = ACTION[state][token];
             if (action.type == ActionType::SHIFT) {
                 states.push(action.state);
                 parseStack.push(new TreeNode(token));
                 pos++;
             }
             else if (action.type == ActionType::REDUCE) {
-                const auto& production = productions[action.production];
-                int pop_count=0;
-                if(production.second[0]==""){
-                    pop_count=0;
-                }else{
-                    pop_count = production.second.size();
+                const ProductionEntry& production = prodTable[action.production];
+                const char* lhs = symbolNames[production.lhs];
+                if (states.size() <= production.rhsLength) {
+                    output = "Error: Stack underflow reducing '" + string(lhs) + "' in state " + to_string(state) + "\n";
+                    return false;
                 }
-                TreeNode* node = new TreeNode(production.first);
+                int pop_count = production.rhsLength;
+                TreeNode* node = new TreeNode(lhs);
                 while (pop_count--) {
                     states.pop();
                     node->children.insert(node->children.begin(), parseStack.top());
@@ -608,18 +1076,22 @@ public:
                 state = states.top();
 
                 // debug log output in console window
-                cout << "Reducing using production: " << production.first << " -> ";
-                for (const auto& sym : production.second) {
-                    cout << sym << " ";
+                if (trace) {
+                    cout << "Reducing using production: " << lhs << " -> ";
+                    for (uint32_t i = 0; i < production.rhsLength; ++i) {
+                        cout << symbolNames[rhsTable[production.rhsBegin + i]] << " ";
+                    }
+                    cout << endl;
+                    printStack(states, parseStack);
                 }
-                cout << endl;
-                printStack(states, parseStack);
-                if (GOTO[state].find(production.first) == GOTO[state].end()) {
-                    output = "Error: No GOTO for production '" + production.first + "' from state " + to_string(state) + "\n";
+                int next = gotoAt(state, production.lhs);
+                if (next < 0) {
+                    delete node;
+                    output = "Error: No GOTO for production '" + string(lhs) + "' from state " + to_string(state) + "\n";
                     output += "Error: Unexpected token '" + token + "' at position " + to_string(pos) + "\n";
                     return false;
                 }
-                states.push(GOTO[state][production.first]);
+                states.push(next);
                 parseStack.push(node);
             }
             else if (action.type == ActionType::ACCEPT) {
@@ -656,9 +1128,302 @@ void writeOutputToFile(const string& filename, const string& content) {
     outfile.close();
 }
 
+// one annotated line of test_set.txt : "<tokens> : accept|decline [golden file]"
+struct CheckCase {
+    int line;
+    vector<string> tokens;
+    string expected;
+    string golden;
+    string problem; // set when the annotation cannot be read, the case then fails without parsing
+};
+
+// lines with no tokens before the last ':' and no accept/decline verdict after it are notes and are skipped
+vector<CheckCase> readCheckCases(const string& filename) {
+    ifstream infile(filename);
+    vector<CheckCase> cases;
+    string text;
+    int line = 0;
+
+    while (getline(infile, text)) {
+        line++;
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        size_t colon = text.rfind(':');
+        if (colon == string::npos) {
+            continue;
+        }
+        istringstream annotation(text.substr(colon + 1));
+        CheckCase entry;
+        string extra;
+        annotation >> entry.expected >> entry.golden >> extra;
+        istringstream sequence(text.substr(0, colon));
+        string token;
+        while (sequence >> token) {
+            entry.tokens.push_back(token);
+        }
+        if ((entry.expected != "accept" && entry.expected != "decline") || !extra.empty()) {
+            if (entry.tokens.empty()) {
+                continue;
+            }
+            entry.problem = "bad annotation '" + text.substr(colon) + "', expected ': accept|decline [golden file]'";
+        }
+        // golden files are named relative to the test set
+        size_t slash = filename.rfind('/');
+        if (!entry.golden.empty() && entry.golden[0] != '/' && slash != string::npos) {
+            entry.golden = filename.substr(0, slash + 1) + entry.golden;
+        }
+        entry.line = line;
+        cases.push_back(entry);
+    }
+
+    return cases;
+}
+
+string readFileText(const string& filename, bool& found) {
+    ifstream infile(filename, ios::binary);
+    found = static_cast<bool>(infile);
+    ostringstream content;
+    content << infile.rdbuf();
+    string text = content.str();
+    text.erase(remove(text.begin(), text.end(), '\r'), text.end());
+    return text;
+}
+
+// grammar fingerprint and tokens/sec of the "total" row of a report written by runCheck,
+// throughput is -1 if the file does not exist
+// returns false if the file exists but has no fingerprint line or no readable "total" row
+bool readBaseline(const string& filename, string& fingerprint, double& throughput, string& error) {
+    throughput = -1;
+    ifstream infile(filename);
+    if (!infile) {
+        return true;
+    }
+    const string fingerprintLine = "# grammar_fingerprint\t";
+    string text;
+    while (getline(infile, text)) {
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        if (text.compare(0, fingerprintLine.size(), fingerprintLine) == 0) {
+            fingerprint = text.substr(fingerprintLine.size());
+        }
+        else if (text.compare(0, 6, "total\t") == 0) {
+            const char* value = text.c_str() + text.rfind('\t') + 1;
+            char* end = nullptr;
+            throughput = strtod(value, &end);
+            if (end == value || *end != '\0' || throughput <= 0) {
+                error = "Error: bad tokens/sec value '" + string(value) + "' in baseline '" + filename + "'\n";
+                return false;
+            }
+        }
+    }
+    if (throughput <= 0) {
+        error = "Error: no total row in baseline '" + filename + "'\n";
+        return false;
+    }
+    if (fingerprint.empty()) {
+        error = "Error: no grammar fingerprint in baseline '" + filename + "'\n";
+        return false;
+    }
+    return true;
+}
+
+// parse every annotated sequence of the test set, check its verdict and golden tree,
+// and time it. writes one tab-separated row per case plus a "total" row to the report.
+// returns false if any case fails or throughput dropped more than threshold below the baseline,
+// or if requireBaseline is set and the baseline file does not exist.
+bool runCheck(Parser& parser, const string& testSetFilename, const string& reportFilename,
+              const string& baselineFilename, double threshold, bool requireBaseline) {
+    const double minSeconds = 0.05; // time each case at least this long
+    vector<CheckCase> cases = readCheckCases(testSetFilename);
+    if (cases.empty()) {
+        cerr << "Error: no annotated sequences in '" << testSetFilename << "'" << endl;
+        return false;
+    }
+
+    parser.trace = false;
+    string fingerprint = fingerprintToString(parser.fingerprint());
+    ostringstream report;
+    report << "# grammar_fingerprint\t" << fingerprint << "\n";
+    report << "# kind\tline\texpected\tactual\tstatus\ttokens_per_parse\titerations\ttokens_processed\tseconds\ttokens_per_sec\n";
+    int passed = 0;
+    long long totalIterations = 0;
+    double totalTokens = 0;
+    double totalSeconds = 0;
+
+    for (const auto& entry : cases) {
+        if (!entry.problem.empty()) {
+            cout << "FAIL line " << entry.line << ": " << entry.problem << endl;
+            report << "case\t" << entry.line << "\t" << (entry.expected.empty() ? "-" : entry.expected) << "\t-\tfail\t"
+                   << entry.tokens.size() + 1 << "\t0\t0\t0\t0\n";
+            continue;
+        }
+
+        string output;
+        TreeNode* parseTree = nullptr;
+        bool accepted = parser.parse(entry.tokens, output, parseTree);
+        string actual = accepted ? "accept" : "decline";
+        ostringstream result;
+        result << output;
+        if (parseTree) {
+            parseTree->writeTreeToFile(result);
+        }
+        delete parseTree;
+
+        string failure;
+        if (actual != entry.expected) {
+            failure = "expected " + entry.expected + ", got " + actual;
+        }
+        else if (!entry.golden.empty()) {
+            bool found = false;
+            string golden = readFileText(entry.golden, found);
+            if (!found) {
+                failure = "cannot read golden file '" + entry.golden + "'";
+            }
+            else if (golden != result.str()) {
+                failure = "parse tree differs from golden file '" + entry.golden + "'";
+            }
+        }
+
+        // each parse reads the tokens plus the end marker '$'
+        long long iterations = 0;
+        double seconds = 0;
+        auto start = chrono::steady_clock::now();
+        while (seconds < minSeconds) {
+            string discard;
+            TreeNode* tree = nullptr;
+            parser.parse(entry.tokens, discard, tree);
+            delete tree;
+            iterations++;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        double tokens = (double)(entry.tokens.size() + 1) * iterations;
+        totalIterations += iterations;
+        totalTokens += tokens;
+        totalSeconds += seconds;
+
+        if (failure.empty()) {
+            passed++;
+            cout << "PASS line " << entry.line << ": " << actual << endl;
+        }
+        else {
+            cout << "FAIL line " << entry.line << ": " << failure << endl;
+        }
+        report << "case\t" << entry.line << "\t" << entry.expected << "\t" << actual << "\t"
+               << (failure.empty() ? "pass" : "fail") << "\t" << entry.tokens.size() + 1 << "\t"
+               << iterations << "\t" << (long long)tokens << "\t" << seconds << "\t" << (long long)(tokens / seconds) << "\n";
+    }
+
+    bool ok = passed == (int)cases.size();
+    double throughput = (totalSeconds > 0) ? totalTokens / totalSeconds : 0;
+    report << "total\t-\t-\t-\t" << (ok ? "pass" : "fail") << "\t-\t" << totalIterations << "\t" << (long long)totalTokens << "\t"
+           << totalSeconds << "\t" << (long long)throughput << "\n";
+    cout << passed << "/" << cases.size() << " cases passed, " << (long long)throughput << " tokens/sec" << endl;
+
+    if (!reportFilename.empty()) {
+        writeOutputToFile(reportFilename, report.str());
+    }
+
+    if (!baselineFilename.empty()) {
+        double baseline = -1;
+        string baselineFingerprint;
+        string error;
+        if (!readBaseline(baselineFilename, baselineFingerprint, baseline, error)) {
+            cerr << error;
+            ok = false;
+        }
+        else if (baseline <= 0 && requireBaseline) {
+            cerr << "Error: no baseline in '" << baselineFilename << "', record one with make baseline" << endl;
+            ok = false;
+        }
+        else if (baseline <= 0) {
+            cout << "No baseline in '" << baselineFilename << "', throughput not compared" << endl;
+        }
+        else if (baselineFingerprint != fingerprint) {
+            cerr << "Error: baseline was measured with grammar " << baselineFingerprint << " but this run uses "
+                 << fingerprint << ", throughput not compared" << endl;
+            ok = false;
+        }
+        else if (throughput < baseline * (1 - threshold)) {
+            cout << "FAIL throughput " << (long long)throughput << " tokens/sec is more than "
+                 << threshold * 100 << "% below baseline " << (long long)baseline << endl;
+            ok = false;
+        }
+        else {
+            cout << "Throughput is within " << threshold * 100 << "% of baseline " << (long long)baseline << endl;
+        }
+    }
+
+    return ok;
+}
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " input.txt output.txt [tables.bin]" << endl;
+    cerr << "       " << program << " --dump-tables tables.bin" << endl;
+    cerr << "       " << program << " --check test_set.txt [--report file] [--baseline file] [--threshold ratio] [--require-baseline] [--tables file]" << endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        cerr << "Usage: " << argv[0] << " input.txt output.txt" << endl;
+    // table file mode : write the built-in tables so they can be loaded (or edited) later
+    if (argc == 3 && string(argv[1]) == "--dump-tables") {
+        Parser parser;
+        string error;
+        if (!parser.writeTables(argv[2], error)) {
+            cerr << error;
+            return 1;
+        }
+        cout << "Wrote " << argv[2] << " (grammar fingerprint " << fingerprintToString(parser.fingerprint()) << ")" << endl;
+        return 0;
+    }
+
+    // check mode : conformance and throughput run over an annotated test set
+    if (argc >= 3 && string(argv[1]) == "--check") {
+        string reportFilename, baselineFilename, tablesFilename;
+        double threshold = 0.2;
+        bool requireBaseline = false;
+        for (int i = 3; i < argc; i++) {
+            string flag = argv[i];
+            if (flag == "--require-baseline") {
+                requireBaseline = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                cerr << "Error: option '" << flag << "' needs a value" << endl;
+                return 1;
+            }
+            string value = argv[++i];
+            if (flag == "--report") reportFilename = value;
+            else if (flag == "--baseline") baselineFilename = value;
+            else if (flag == "--threshold") {
+                // fraction of the baseline throughput that may be lost, in [0, 1)
+                char* end = nullptr;
+                threshold = strtod(value.c_str(), &end);
+                if (end == value.c_str() || *end != '\0' || !(threshold >= 0 && threshold < 1)) {
+                    cerr << "Error: --threshold needs a ratio in [0, 1), got '" << value << "'" << endl;
+                    printUsage(argv[0]);
+                    return 1;
+                }
+            }
+            else if (flag == "--tables") tablesFilename = value;
+            else {
+                cerr << "Error: unknown option '" << flag << "'" << endl;
+                return 1;
+            }
+        }
+
+        Parser parser;
+        string error;
+        bool loaded = tablesFilename.empty() ? parser.useBuiltinTables(error) : parser.loadTables(tablesFilename, error);
+        if (!loaded) {
+            cerr << error;
+            return 1;
+        }
+        return runCheck(parser, argv[2], reportFilename, baselineFilename, threshold, requireBaseline) ? 0 : 1;
+    }
+
+    if (argc != 3 && argc != 4) {
+        printUsage(argv[0]);
         return 1;
     }
 
@@ -666,6 +1431,13 @@ int main(int argc, char* argv[]) {
     string outputFilename = argv[2];
 
     Parser parser;
+    string error;
+    bool loaded = (argc == 4) ? parser.loadTables(argv[3], error) : parser.useBuiltinTables(error);
+    if (!loaded) {
+        cerr << error;
+        return 1;
+    }
+    cout << "Grammar fingerprint: " << fingerprintToString(parser.fingerprint()) << endl;
 
     vector<string> tokens = readTokensFromFile(inputFilename);
     string output;